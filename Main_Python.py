@@ -14,6 +14,7 @@ import pandas as pd
 from sklearn.tree import DecisionTreeRegressor
 from collections import Counter
 from itertools import cycle, islice
+import exchange_format
 #loading data
 #----------------------------------------------------------------------loading data CAD----------------------------------------------------------
 
@@ -22,19 +23,8 @@ from itertools import cycle, islice
 source_path = 'C:\\Users\\prasa\\Desktop\\dataset\\master_stl\\reading_2\\centroid_cad.pcd'
 
 
-#loading points from pcd
-cnt = 0
-linar = []
-#source_dt = open("tr_pcd.pcd", "r") 
-source_dt = open(source_path, "r") 
-for lin in source_dt:
-		cnt = cnt + 1
-		if(cnt>11):
-			linar.append(lin)
-final = []
-for eachl in linar:
-	final.append(list(eachl.split()))
-big_vertical_sc_list = list(np.array(final).astype(np.float))
+#loading points from pcd (ascii, binary or compressed), keypoint exchange file or Result_Points text
+big_vertical_sc_list = list(exchange_format.read_points(source_path))
 
 
 
@@ -54,21 +44,7 @@ decision_tree_split_train = open(decision_tree_pkl_filename, 'rb')
 
 #loading points from pcd
 if(load_pcd_data == 1 ):
-    cnt = 0
-    linar = []
-    strlin = []
-    #target_dt = open("tr_pcd_tar.pcd", "r") 
-    target_dt = open(target_path, "r") 
-    for lin in target_dt:
-            cnt = cnt + 1
-            if(cnt<12):
-                strlin.append(lin)
-            if(cnt>11):
-                linar.append(lin)
-    final = []
-    for eachl in linar: 
-        final.append(list(eachl.split()))
-    big_vertical_tr_list = list(np.array(final).astype(np.float))
+    big_vertical_tr_list = list(exchange_format.read_points(target_path))
 
 #global variables
 big_vertical_tr = np.array(big_vertical_tr_list)
@@ -97,15 +73,17 @@ def save_transformation(ans_noise_filter):
     tr_mat = np.mat(tr_ptCloud)
     
     mat_rot, mat_trans = rigid_transform_3D(sc_mat, tr_mat)
-    #write in txt
+    #write in txt (the transformation argument of the C++ menu)
     file_trans_matwo= open("trans_exchange.txt","w")
     low_val1 = np.mat(np.array([0, 0, 0, 1]).reshape(1,4))
     up_val1 = np.hstack((mat_rot,mat_trans.T))
-    fin_4x41 = np.vstack((up_val1,low_val1)).tolist()
-    for each_mat_elem in fin_4x41:
+    fin_4x41 = np.vstack((up_val1,low_val1))
+    for each_mat_elem in fin_4x41.tolist():
         each_mat_elem = str(list(each_mat_elem)).replace("[","").replace("]","").replace(",","")
         file_trans_matwo.write( str(each_mat_elem) + '\n')
     file_trans_matwo.close()
+    #same transform as binary exchange file
+    exchange_format.write_transform("trans_exchange.bin", fin_4x41)
 
 
 #estimate transformation between two sets of points
@@ -0,0 +1,244 @@
+# -*- coding: utf-8 -*-
+"""
+Exchange files between Coarse_Alignment_Standalone and Main_Python.py
+
+Binary exchange file : 32 byte header (magic, version, kind, rows, cols, reserved)
+followed by rows * cols little endian float32 in row major order.
+kind 1 keypoints (x y z per row), 2 correspondences (residual, CAD index per camera
+keypoint or -1), 3 transform (4x4), 4 cloud (x y z per row).
+
+localize() is the client of the server mode (Coarse_Alignment_Standalone --serve),
+over a Unix domain socket, or a named pipe on Windows.
+"""
+
+import os
+import socket
+import struct
+import numpy as np
+
+EXCHANGE_MAGIC = b'CAXCHG\x00\x00'
+EXCHANGE_VERSION = 1
+EXCHANGE_KEYPOINTS = 1
+EXCHANGE_CORRESPONDENCES = 2
+EXCHANGE_TRANSFORM = 3
+EXCHANGE_CLOUD = 4
+_HEADER = struct.Struct('<8sIIIIII')
+
+SERVE_REQUEST_MAGIC = b'CASCAN\x00\x00'
+SERVE_RESPONSE_MAGIC = b'CARSLT\x00\x00'
+SERVE_VERSION = 1
+SERVE_SCAN = 0
+SERVE_SCAN_FILE = 1
+SERVE_SHUTDOWN = 2
+_REQUEST = struct.Struct('<8sIIII')
+_RESPONSE = struct.Struct('<8sIiIIIff16f')
+if os.name == 'nt':
+    SERVE_DEFAULT_PATH = r'\\.\pipe\coarse_alignment'
+else:
+    SERVE_DEFAULT_PATH = '/tmp/coarse_alignment.sock'
+
+
+#writing an exchange file
+def write_exchange(path, kind, data):
+    data = np.ascontiguousarray(data, dtype='<f4')
+    if data.ndim != 2:
+        raise ValueError('exchange data must be two dimensional')
+    with open(path, 'wb') as exchange_file:
+        exchange_file.write(_HEADER.pack(EXCHANGE_MAGIC, EXCHANGE_VERSION, kind, data.shape[0], data.shape[1], 0, 0))
+        exchange_file.write(data.tobytes())
+
+
+#reading an exchange file, memory mapped (no copy) as rows x cols float32 array
+def read_exchange(path, kind=None):
+    with open(path, 'rb') as exchange_file:
+        header = exchange_file.read(_HEADER.size)
+    if len(header) < _HEADER.size:
+        raise ValueError(path + ' is not an exchange file')
+    magic, version, file_kind, rows, cols = _HEADER.unpack(header)[:5]
+    if magic != EXCHANGE_MAGIC or version != EXCHANGE_VERSION:
+        raise ValueError(path + ' is not a version ' + str(EXCHANGE_VERSION) + ' exchange file')
+    if kind is not None and file_kind != kind:
+        raise ValueError(path + ' holds kind ' + str(file_kind) + ', expected ' + str(kind))
+    if rows * cols == 0:
+        return np.zeros((rows, cols), dtype='<f4')
+    return np.memmap(path, dtype='<f4', mode='r', offset=_HEADER.size, shape=(rows, cols))
+
+
+def is_exchange_file(path):
+    with open(path, 'rb') as exchange_file:
+        return exchange_file.read(len(EXCHANGE_MAGIC)) == EXCHANGE_MAGIC
+
+
+def write_keypoints(path, points):
+    write_exchange(path, EXCHANGE_KEYPOINTS, np.asarray(points, dtype=np.float64)[:, 0:3])
+
+
+def write_cloud(path, points):
+    write_exchange(path, EXCHANGE_CLOUD, np.asarray(points, dtype=np.float64)[:, 0:3])
+
+
+def write_transform(path, transform):
+    write_exchange(path, EXCHANGE_TRANSFORM, np.asarray(transform, dtype=np.float64).reshape(4, 4))
+
+
+def read_transform(path):
+    return np.array(read_exchange(path, EXCHANGE_TRANSFORM), dtype=np.float64)
+
+
+#correspondences as (residuals, CAD index array with one row per candidate)
+def read_correspondences(path):
+    data = read_exchange(path, EXCHANGE_CORRESPONDENCES)
+    return np.array(data[:, 0]), np.array(data[:, 1:], dtype=np.int64)
+
+
+#LZF decompression of binary_compressed PCD data
+def _lzf_decompress(data, size):
+    out = bytearray(size)
+    i = 0
+    o = 0
+    while i < len(data):
+        ctrl = data[i]
+        i += 1
+        if ctrl < 32:
+            out[o:o + ctrl + 1] = data[i:i + ctrl + 1]
+            i += ctrl + 1
+            o += ctrl + 1
+        else:
+            length = ctrl >> 5
+            ref = o - ((ctrl & 0x1f) << 8) - 1
+            if length == 7:
+                length += data[i]
+                i += 1
+            ref -= data[i]
+            i += 1
+            for k in range(length + 2):
+                out[o] = out[ref + k]
+                o += 1
+    return bytes(out)
+
+
+#reading x y z of a PCD file (ascii, binary or binary_compressed) from its header
+def read_pcd_points(path):
+    with open(path, 'rb') as pcd_file:
+        header = {}
+        while True:
+            line = pcd_file.readline()
+            if not line:
+                raise ValueError(path + ' has no DATA line')
+            words = line.decode('ascii', 'replace').split()
+            if not words or words[0].startswith('#'):
+                continue
+            header[words[0]] = words[1:]
+            if words[0] == 'DATA':
+                break
+        body = pcd_file.read()
+
+    fields = header['FIELDS']
+    sizes = [int(v) for v in header['SIZE']]
+    types = header['TYPE']
+    counts = [int(v) for v in header.get('COUNT', ['1'] * len(fields))]
+    points = int(header['POINTS'][0])
+    data_type = header['DATA'][0]
+    columns = [fields.index(axis) for axis in ('x', 'y', 'z')]
+
+    if data_type == 'ascii':
+        table = np.loadtxt(body.decode('ascii').splitlines(), ndmin=2)
+        offsets = np.cumsum([0] + counts)
+        return table[:points, [offsets[c] for c in columns]]
+
+    kinds = {'F': '<f', 'U': '<u', 'I': '<i'}
+    field_types = [kinds[types[f]] + str(sizes[f]) for f in range(len(fields))]
+    if data_type == 'binary':
+        record_type = np.dtype([(name, field_types[f], (counts[f],)) if counts[f] > 1 else (name, field_types[f])
+                                for f, name in enumerate(fields)])
+        record = np.frombuffer(body, dtype=record_type, count=points)
+        return np.stack([record[fields[c]].astype(np.float64) for c in columns], axis=1)
+    if data_type == 'binary_compressed':
+        compressed_size, uncompressed_size = struct.unpack('<II', body[:8])
+        raw = _lzf_decompress(bytearray(body[8:8 + compressed_size]), uncompressed_size)
+        #fields are stored one after another (structure of arrays)
+        offset = 0
+        by_field = {}
+        for f in range(len(fields)):
+            if f in columns:
+                by_field[f] = np.frombuffer(raw, dtype=field_types[f], count=points * counts[f], offset=offset)[::counts[f]]
+            offset += sizes[f] * counts[f] * points
+        return np.stack([by_field[c].astype(np.float64) for c in columns], axis=1)
+    raise ValueError(path + ' has unknown DATA ' + data_type)
+
+
+#reading keypoints from an exchange file, a PCD file or an x y z [1] text file
+def read_points(path):
+    if is_exchange_file(path):
+        return np.array(read_exchange(path, EXCHANGE_KEYPOINTS), dtype=np.float64)
+    if path.lower().endswith('.pcd'):
+        return read_pcd_points(path)
+    return np.loadtxt(path, ndmin=2)[:, 0:3]
+
+
+#named pipe client with the socket calls used below
+class _PipeConnection(object):
+    def __init__(self, path):
+        self._pipe = open(path, 'r+b', buffering=0)
+
+    def sendall(self, data):
+        view = memoryview(data)
+        while len(view) > 0:
+            view = view[self._pipe.write(view):]
+
+    def recv(self, size):
+        return self._pipe.read(size)
+
+    def close(self):
+        self._pipe.close()
+
+
+def _connect(socket_path):
+    if os.name == 'nt':
+        return _PipeConnection(socket_path)
+    connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    connection.connect(socket_path)
+    return connection
+
+
+def _receive(connection, size):
+    data = b''
+    while len(data) < size:
+        chunk = connection.recv(size - len(data))
+        if not chunk:
+            raise IOError('server closed the connection')
+        data += chunk
+    return data
+
+
+#localizing a scan on the server, scan is an N x 3 array or the path of a PCD / exchange cloud file
+#(a file in /dev/shm avoids sending the points through the socket)
+#returns status (0 localized), 4x4 transform, fitness and server side latency in ms
+def localize(scan, model=0, socket_path=SERVE_DEFAULT_PATH):
+    connection = _connect(socket_path)
+    try:
+        if isinstance(scan, str):
+            path = scan.encode('utf-8')
+            connection.sendall(_REQUEST.pack(SERVE_REQUEST_MAGIC, SERVE_VERSION, SERVE_SCAN_FILE, model, len(path)) + path)
+        else:
+            points = np.ascontiguousarray(np.asarray(scan)[:, 0:3], dtype='<f4')
+            connection.sendall(_REQUEST.pack(SERVE_REQUEST_MAGIC, SERVE_VERSION, SERVE_SCAN, model, points.shape[0]) + points.tobytes())
+        response = _RESPONSE.unpack(_receive(connection, _RESPONSE.size))
+    finally:
+        connection.close()
+    if response[0] != SERVE_RESPONSE_MAGIC:
+        raise IOError('invalid server response')
+    status, fitness, latency = response[2], response[6], response[7]
+    return status, np.array(response[8:24], dtype=np.float64).reshape(4, 4), fitness, latency
+
+
+#stopping the server, only accepted when it runs with --allow-shutdown
+#returns True when the server is stopping
+def shutdown_server(socket_path=SERVE_DEFAULT_PATH):
+    connection = _connect(socket_path)
+    try:
+        connection.sendall(_REQUEST.pack(SERVE_REQUEST_MAGIC, SERVE_VERSION, SERVE_SHUTDOWN, 0, 0))
+        response = _RESPONSE.unpack(_receive(connection, _RESPONSE.size))
+    finally:
+        connection.close()
+    return response[0] == SERVE_RESPONSE_MAGIC and response[2] == 0